@@ -0,0 +1,215 @@
+#include "pipeline.h"
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <format>
+#include <fstream>
+#include <ctime>
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+constexpr int NUM_ACCOUNTS = 16; // account NUM_ACCOUNTS is left without limits and always rejected
+// tight enough that large and expensive orders get rejected, and accounts run
+// into their gross limit towards the end of a run
+RiskLimits riskLimits(std::size_t numOperations) {
+    return {80, 8'000.0, static_cast<long long>(numOperations)};
+}
+
+// mostly adds, with cancels and modifies of earlier orders (sometimes from the
+// wrong account) and the odd zero quantity the decoder has to reject
+std::vector<OrderCommand> generateCommands(int numOperations) {
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<> priceDist(95.0, 105.0);
+    std::uniform_int_distribution<> quantityDist(0, 100);
+    std::uniform_int_distribution<> sideDist(0, 1);
+    std::uniform_int_distribution<> accountDist(0, NUM_ACCOUNTS);
+    std::uniform_int_distribution<> percentDist(1, 100);
+
+    std::vector<OrderCommand> commands(numOperations);
+    std::vector<int> owners; // orderId -> account that added it
+    for (int i = 0; i < numOperations; ++i) {
+        OrderCommand& command = commands[i];
+        int operationType = percentDist(gen);
+        if (owners.empty() || operationType <= 70) {
+            command.type = CommandType::ADD;
+            command.accountId = accountDist(gen);
+            command.orderId = static_cast<int>(owners.size());
+            command.price = priceDist(gen);
+            command.quantity = quantityDist(gen);
+            command.isBuy = sideDist(gen) == 1;
+            owners.push_back(command.accountId);
+            continue;
+        }
+        command.type = operationType <= 85 ? CommandType::CANCEL : CommandType::MODIFY;
+        command.orderId = std::uniform_int_distribution<>(0, static_cast<int>(owners.size()) - 1)(gen);
+        command.accountId = percentDist(gen) <= 90 ? owners[command.orderId] : accountDist(gen);
+        if (command.type == CommandType::MODIFY) {
+            if (sideDist(gen) == 1) {
+                command.newPrice = priceDist(gen);
+            }
+            if (percentDist(gen) <= 70) {
+                command.newQuantity = quantityDist(gen);
+            }
+        }
+    }
+    return commands;
+}
+
+struct BookSummary {
+    int bidVolume;
+    int askVolume;
+    std::size_t tradeCount;
+    int64_t rejected;
+
+    bool operator==(const BookSummary&) const = default;
+};
+
+BookSummary summarize(const OrderBook& book, int64_t rejected) {
+    VolumeInfo volume = book.getVolumeInfo();
+    return {volume.bidVolume, volume.askVolume,
+            book.getRecentTrades(std::numeric_limits<int>::max()).size(), rejected};
+}
+
+struct LatencySummary {
+    double avg;
+    int64_t p50;
+    int64_t p99;
+    int64_t max;
+};
+
+LatencySummary summarizeLatency(std::vector<int64_t> samples) {
+    if (samples.empty()) {
+        return {0.0, 0, 0, 0};
+    }
+    std::sort(samples.begin(), samples.end());
+    double total = 0.0;
+    for (int64_t sample : samples) {
+        total += sample;
+    }
+    auto percentile = [&samples](double p) { return samples[static_cast<std::size_t>(p * (samples.size() - 1))]; };
+    return {total / samples.size(), percentile(0.50), percentile(0.99), samples.back()};
+}
+
+struct RunResult {
+    double seconds;
+    LatencySummary latency;
+    std::vector<BookSummary> books; // book state at the end of each run
+};
+
+// risk check and matching on the caller's thread, as addOrder is used today
+RunResult runInline(const std::vector<OrderCommand>& commands) {
+    OrderBook book;
+    RiskChecker checker;
+    for (int account = 0; account < NUM_ACCOUNTS; ++account) {
+        checker.setLimits(account, riskLimits(commands.size()));
+    }
+    std::vector<int64_t> latencies;
+    latencies.reserve(commands.size());
+    int64_t rejected = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& command : commands) {
+        auto begin = std::chrono::steady_clock::now();
+        if (isWellFormed(command) && checker.check(command, book)) {
+            applyCommand(book, command);
+        } else {
+            ++rejected;
+        }
+        latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count());
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return {elapsed.count(), summarizeLatency(std::move(latencies)), {summarize(book, rejected)}};
+}
+
+OrderPipeline makePipeline(WaitStrategy strategy, std::size_t latencySamples) {
+    PipelineConfig config;
+    config.waitStrategy = strategy;
+    config.latencySampleCapacity = latencySamples;
+    unsigned int cores = std::thread::hardware_concurrency();
+    if (cores >= 4) { // core 0 is the producer's, see main()
+        config.sequencerCore = 1;
+        config.riskCore = 2;
+        config.matcherCore = 3;
+    }
+    return OrderPipeline(config);
+}
+
+// throughput comes from a saturated run, but its publish -> matched times are
+// mostly queueing in the ring, so latency comes from a closed-loop run with a
+// single command in flight
+RunResult runPipeline(const std::vector<OrderCommand>& commands, WaitStrategy strategy) {
+    double seconds;
+    BookSummary saturatedBook;
+    {
+        OrderPipeline pipeline = makePipeline(strategy, 0); // no sampling, so no clock reads on the matcher
+        for (int account = 0; account < NUM_ACCOUNTS; ++account) {
+            pipeline.setRiskLimits(account, riskLimits(commands.size()));
+        }
+        pipeline.start();
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& command : commands) {
+            pipeline.publish(command);
+        }
+        pipeline.drain();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        pipeline.stop();
+        seconds = elapsed.count();
+        saturatedBook = summarize(pipeline.getOrderBook(), pipeline.getStats().rejected);
+    }
+
+    OrderPipeline pipeline = makePipeline(strategy, commands.size());
+    for (int account = 0; account < NUM_ACCOUNTS; ++account) {
+        pipeline.setRiskLimits(account, riskLimits(commands.size()));
+    }
+    pipeline.start();
+    for (const auto& command : commands) {
+        pipeline.publish(command);
+        pipeline.drain();
+    }
+    pipeline.stop();
+    PipelineStats stats = pipeline.getStats();
+    return {seconds, summarizeLatency(pipeline.getLatencySamples()),
+            {saturatedBook, summarize(pipeline.getOrderBook(), stats.rejected)}};
+}
+
+int main() {
+    const std::vector<int> OPERATION_COUNTS = {10000, 100000, 1000000};
+    std::ofstream logFile("benchmark/results.txt", std::ios::app);
+    std::time_t now = std::time(nullptr);
+    logFile << "\n=== Pipeline Benchmark Run: " << std::ctime(&now);
+    logFile << "Hardware threads: " << std::thread::hardware_concurrency() << "\n\n";
+    if (std::thread::hardware_concurrency() >= 4) {
+        // keep the producer (and the inline path) off the stage cores
+        OrderPipeline::pinCurrentThread(0);
+    }
+
+    for (int numOperations : OPERATION_COUNTS) {
+        auto commands = generateCommands(numOperations);
+        std::vector<std::pair<std::string, RunResult>> results;
+        results.emplace_back("inline", runInline(commands));
+        // busy-spin needs a core per spinning thread, otherwise every handoff waits for a time slice
+        if (std::thread::hardware_concurrency() >= 4) {
+            results.emplace_back("pipeline/busy-spin", runPipeline(commands, WaitStrategy::BUSY_SPIN));
+        }
+        results.emplace_back("pipeline/yield", runPipeline(commands, WaitStrategy::YIELD));
+        // every run must leave the book in the same state as the inline path
+        const BookSummary expected = results[0].second.books[0];
+        for (const auto& [name, result] : results) {
+            for (const auto& book : result.books) {
+                if (book != expected) {
+                    std::cerr << std::format("{} book diverged from inline book at {} operations\n", name, numOperations);
+                    return 1;
+                }
+            }
+        }
+        for (const auto& [name, result] : results) {
+            std::string line = std::format("{:<18} | Operations: {:>7} | Time: {:.4f}s | Throughput: {:>10.0f} operations/sec | Latency avg: {:>7.0f}ns p50: {:>7}ns p99: {:>8}ns max: {:>10}ns\n",
+                                           name, numOperations, result.seconds, numOperations / result.seconds,
+                                           result.latency.avg, result.latency.p50, result.latency.p99, result.latency.max);
+            std::cout << line;
+            logFile << line;
+        }
+    }
+    logFile << "\n";
+}
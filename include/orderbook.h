@@ -23,6 +23,7 @@ public:
     [[nodiscard]] std::vector<Trade> getRecentTrades(int n) const noexcept;
     [[nodiscard]] std::optional<double> getSpread() const noexcept;
     int getVolumeAtPrice(double price, bool isBuy) const noexcept;
+    [[nodiscard]] int getOrderQuantity(int orderId) const noexcept; // 0 if not resting
     void printDepth(int levels = 5) const;
     [[nodiscard]] std::optional<double> getMidPrice() const noexcept;
     [[nodiscard]] double getVWAP() const noexcept;
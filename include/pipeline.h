@@ -0,0 +1,159 @@
+#pragma once
+#include "orderbook.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+enum class CommandType {
+    ADD,
+    CANCEL,
+    MODIFY
+};
+
+enum class WaitStrategy {
+    BUSY_SPIN, // lowest latency, burns a full core per stage
+    YIELD      // gives the core back to the scheduler while idle
+};
+
+// one preallocated slot in the ring, written by the producer and then
+// handed from stage to stage without copying
+struct OrderCommand {
+    CommandType type = CommandType::ADD;
+    int accountId = 0;
+    int orderId = 0;
+    double price = 0.0;
+    int quantity = 0;
+    bool isBuy = false;
+    OrderType orderType = OrderType::LIMIT;
+    double stopPrice = 0.0;
+    std::optional<double> newPrice;
+    std::optional<int> newQuantity;
+    bool rejected = false;
+    int64_t publishTimeNs = 0; // only stamped when latency sampling is on
+};
+
+// decoder checks run by the sequencer stage, shared with inline callers
+[[nodiscard]] bool isWellFormed(const OrderCommand& command) noexcept;
+void applyCommand(OrderBook& book, const OrderCommand& command);
+
+struct RiskLimits {
+    int maxOrderQuantity;
+    double maxOrderNotional;
+    long long maxGrossQuantity; // total quantity an account may submit
+};
+
+class RiskChecker {
+public:
+    explicit RiskChecker(bool allowUnknownAccounts = false) : allowUnknownAccounts(allowUnknownAccounts) {}
+    void setLimits(int accountId, const RiskLimits& limits);
+    // true when check() will read the book, which must then reflect every
+    // earlier command (resting quantities decide modifies, cancels and pruning)
+    [[nodiscard]] bool needsBook(const OrderCommand& command) const noexcept;
+    // accounts without configured limits are rejected unless allowUnknownAccounts
+    // is set, in which case they skip the limit checks; cancels and modifies are
+    // always checked against the account that placed the order
+    bool check(const OrderCommand& command, const OrderBook& book);
+
+private:
+    struct AccountState {
+        RiskLimits limits;
+        long long grossQuantity = 0;
+    };
+    struct OrderState {
+        int accountId;
+        double price;
+        bool hasPrice;
+    };
+    static constexpr std::size_t MIN_PRUNE_THRESHOLD = 1024;
+    bool checkModify(const OrderCommand& command, const OrderBook& book);
+    void prune(const OrderBook& book);
+    std::unordered_map<int, AccountState> accounts;
+    std::unordered_map<int, OrderState> orders; // orderId -> accepted order, may include dead ones until pruned
+    std::size_t pruneThreshold = MIN_PRUNE_THRESHOLD;
+    bool allowUnknownAccounts;
+};
+
+// sequence counter padded to its own cache line so stages don't false share
+struct alignas(CACHE_LINE_SIZE) PaddedSequence {
+    std::atomic<int64_t> value{-1};
+};
+
+struct PipelineConfig {
+    std::size_t ringSize = 1 << 16; // must be a power of two
+    WaitStrategy waitStrategy = WaitStrategy::BUSY_SPIN;
+    int sequencerCore = -1; // -1 leaves the thread unpinned
+    int riskCore = -1;
+    int matcherCore = -1;
+    bool allowUnknownAccounts = false; // let accounts without risk limits through unchecked
+    std::size_t latencySampleCapacity = 0; // publish -> matched samples to keep, 0 keeps the clock off the hot path
+};
+
+struct PipelineStats {
+    int64_t processed;
+    int64_t rejected;
+};
+
+// LMAX Disruptor style pipeline: producer -> sequencer/decoder -> pre-trade
+// risk -> matcher, each stage on its own thread and gated only on the
+// sequence of the stage before it
+class OrderPipeline {
+public:
+    explicit OrderPipeline(const PipelineConfig& config = PipelineConfig());
+    ~OrderPipeline();
+    OrderPipeline(const OrderPipeline&) = delete;
+    OrderPipeline& operator=(const OrderPipeline&) = delete;
+
+    void setRiskLimits(int accountId, const RiskLimits& limits); // throws while running
+    void start();
+    void stop(); // drains outstanding commands before joining
+
+    // single producer only, both throw unless started
+    void publish(const OrderCommand& command);
+    void drain() const;
+
+    // pins the calling thread, e.g. the producer, with the same rules as the stages
+    static void pinCurrentThread(int core);
+
+    // only safe to read once drained or stopped
+    [[nodiscard]] const OrderBook& getOrderBook() const noexcept { return book; }
+    [[nodiscard]] PipelineStats getStats() const noexcept;
+    [[nodiscard]] const std::vector<int64_t>& getLatencySamples() const noexcept { return latencySamples; }
+
+private:
+    void runSequencer();
+    void runRisk();
+    void runMatcher();
+    void waitForMatcher(int64_t sequence);
+    int64_t waitFor(const PaddedSequence& dependency, int64_t sequence) const;
+    void idle() const noexcept;
+    static void pinToCore(std::thread& thread, int core);
+
+    // cold state, only touched by start()/stop() and read-only while running
+    PipelineConfig config;
+    std::size_t mask;
+    std::unique_ptr<OrderCommand[]> ring;
+    std::thread sequencerThread;
+    std::thread riskThread;
+    std::thread matcherThread;
+
+    PaddedSequence published;
+    PaddedSequence sequenced;
+    PaddedSequence riskChecked;
+    PaddedSequence matched;
+    alignas(CACHE_LINE_SIZE) std::atomic<bool> running{false};
+
+    // each thread's private state starts on its own cache line
+    alignas(CACHE_LINE_SIZE) int64_t nextSequence = 0; // producer
+    int64_t cachedGate = -1;                           // producer's view of matched
+    alignas(CACHE_LINE_SIZE) RiskChecker riskChecker;  // risk thread once started
+    alignas(CACHE_LINE_SIZE) OrderBook book;           // matcher thread once started
+    int64_t processedCount = 0;
+    int64_t rejectedCount = 0;
+    std::vector<int64_t> latencySamples; // preallocated, never grows past latencySampleCapacity
+};
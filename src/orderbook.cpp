@@ -91,6 +91,14 @@ bool OrderBook::cancelOrder(int orderId) {
     return true; 
 }
 
+int OrderBook::getOrderQuantity(int orderId) const noexcept {
+    auto indexIt = orderIndex.find(orderId);
+    if (indexIt == orderIndex.end()) {
+        return 0;
+    }
+    return indexIt->second->quantity;
+}
+
 std::optional<Order> OrderBook::bestBid() const noexcept {
     if (bids.empty()) {
         return std::nullopt;
@@ -0,0 +1,361 @@
+#include "pipeline.h"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+int64_t nowNs() noexcept {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#ifdef __linux__
+void setAffinity(pthread_t handle, int core) {
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(core, &cpuset);
+    int result = pthread_setaffinity_np(handle, sizeof(cpu_set_t), &cpuset);
+    if (result != 0) {
+        throw std::system_error(result, std::generic_category(), "failed to pin thread to core " + std::to_string(core));
+    }
+}
+#endif
+}
+
+bool isWellFormed(const OrderCommand& command) noexcept {
+    switch (command.type) {
+        case CommandType::ADD: {
+            bool needsPrice = command.orderType != OrderType::MARKET && command.orderType != OrderType::STOP_LOSS;
+            return command.quantity > 0 && (!needsPrice || command.price > 0.0);
+        }
+        case CommandType::MODIFY:
+            return (!command.newQuantity.has_value() || command.newQuantity.value() > 0) &&
+                (!command.newPrice.has_value() || command.newPrice.value() > 0.0);
+        case CommandType::CANCEL:
+            break;
+    }
+    return true;
+}
+
+void applyCommand(OrderBook& book, const OrderCommand& command) {
+    switch (command.type) {
+        case CommandType::ADD:
+            book.addOrder(Order(command.orderId, command.price, command.quantity, command.isBuy,
+                                command.orderType, command.stopPrice));
+            break;
+        case CommandType::CANCEL:
+            book.cancelOrder(command.orderId);
+            break;
+        case CommandType::MODIFY:
+            book.modifyOrder(command.orderId, command.newPrice, command.newQuantity);
+            break;
+    }
+}
+
+void RiskChecker::setLimits(int accountId, const RiskLimits& limits) {
+    accounts[accountId].limits = limits;
+}
+
+bool RiskChecker::needsBook(const OrderCommand& command) const noexcept {
+    return command.type != CommandType::ADD || orders.size() >= pruneThreshold;
+}
+
+bool RiskChecker::check(const OrderCommand& command, const OrderBook& book) {
+    if (command.type == CommandType::MODIFY) {
+        return checkModify(command, book);
+    }
+    if (command.type == CommandType::CANCEL) {
+        auto orderIt = orders.find(command.orderId);
+        if (orderIt == orders.end() || orderIt->second.accountId != command.accountId) {
+            return false;
+        }
+        bool resting = book.getOrderQuantity(command.orderId) > 0;
+        orders.erase(orderIt);
+        return resting;
+    }
+
+    if (orders.size() >= pruneThreshold) {
+        prune(book);
+    }
+    // a live id would hand the existing order to whoever reused it
+    if (orders.contains(command.orderId)) {
+        return false;
+    }
+    // market and stop orders have no limit price to value them at
+    bool hasPrice = command.orderType != OrderType::MARKET && command.orderType != OrderType::STOP_LOSS;
+    auto it = accounts.find(command.accountId);
+    if (it == accounts.end() && !allowUnknownAccounts) {
+        return false;
+    }
+    if (it != accounts.end()) {
+        AccountState& account = it->second;
+        if (command.quantity > account.limits.maxOrderQuantity) {
+            return false;
+        }
+        if (hasPrice && command.price * command.quantity > account.limits.maxOrderNotional) {
+            return false;
+        }
+        if (account.grossQuantity + command.quantity > account.limits.maxGrossQuantity) {
+            return false;
+        }
+        account.grossQuantity += command.quantity;
+    }
+    orders.emplace(command.orderId, OrderState{command.accountId, command.price, hasPrice});
+    return true;
+}
+
+bool RiskChecker::checkModify(const OrderCommand& command, const OrderBook& book) {
+    auto orderIt = orders.find(command.orderId);
+    if (orderIt == orders.end() || orderIt->second.accountId != command.accountId) {
+        return false;
+    }
+    int remaining = book.getOrderQuantity(command.orderId);
+    if (remaining == 0) { // filled or never rested
+        orders.erase(orderIt);
+        return false;
+    }
+    OrderState& order = orderIt->second;
+    double newPrice = command.newPrice.value_or(order.price);
+    int newQuantity = command.newQuantity.value_or(remaining);
+
+    auto it = accounts.find(command.accountId);
+    if (it == accounts.end() && !allowUnknownAccounts) {
+        return false;
+    }
+    if (it != accounts.end()) {
+        AccountState& account = it->second;
+        if (newQuantity > account.limits.maxOrderQuantity) {
+            return false;
+        }
+        if (order.hasPrice && newPrice * newQuantity > account.limits.maxOrderNotional) {
+            return false;
+        }
+        // topping a partly filled order back up is new quantity
+        int increase = std::max(0, newQuantity - remaining);
+        if (account.grossQuantity + increase > account.limits.maxGrossQuantity) {
+            return false;
+        }
+        account.grossQuantity += increase;
+    }
+    order.price = newPrice;
+    return true;
+}
+
+void RiskChecker::prune(const OrderBook& book) {
+    std::erase_if(orders, [&book](const auto& entry) { return book.getOrderQuantity(entry.first) == 0; });
+    pruneThreshold = std::max(MIN_PRUNE_THRESHOLD, orders.size() * 2);
+}
+
+OrderPipeline::OrderPipeline(const PipelineConfig& config)
+    : config(config), mask(config.ringSize - 1), ring(std::make_unique<OrderCommand[]>(config.ringSize)),
+      riskChecker(config.allowUnknownAccounts) {
+    if (config.ringSize == 0 || (config.ringSize & mask) != 0) {
+        throw std::invalid_argument("ring size must be a power of two");
+    }
+    latencySamples.reserve(config.latencySampleCapacity);
+#ifdef __linux__
+    for (int core : {config.sequencerCore, config.riskCore, config.matcherCore}) {
+        if (core >= CPU_SETSIZE) {
+            throw std::invalid_argument("core id out of range");
+        }
+    }
+#endif
+}
+
+OrderPipeline::~OrderPipeline() {
+    stop();
+}
+
+void OrderPipeline::setRiskLimits(int accountId, const RiskLimits& limits) {
+    if (running.load()) {
+        throw std::logic_error("risk limits can only be changed while the pipeline is stopped");
+    }
+    riskChecker.setLimits(accountId, limits);
+}
+
+void OrderPipeline::start() {
+    if (running.exchange(true)) {
+        return;
+    }
+    matcherThread = std::thread(&OrderPipeline::runMatcher, this);
+    riskThread = std::thread(&OrderPipeline::runRisk, this);
+    sequencerThread = std::thread(&OrderPipeline::runSequencer, this);
+    try {
+        pinToCore(sequencerThread, config.sequencerCore);
+        pinToCore(riskThread, config.riskCore);
+        pinToCore(matcherThread, config.matcherCore);
+    } catch (...) {
+        stop();
+        throw;
+    }
+}
+
+void OrderPipeline::stop() {
+    if (!running.load()) {
+        return;
+    }
+    drain();
+    running.store(false);
+    sequencerThread.join();
+    riskThread.join();
+    matcherThread.join();
+}
+
+void OrderPipeline::publish(const OrderCommand& command) {
+    if (!running.load(std::memory_order_relaxed)) {
+        throw std::logic_error("pipeline must be started before publishing");
+    }
+    int64_t sequence = nextSequence++;
+    int64_t wrapPoint = sequence - static_cast<int64_t>(config.ringSize);
+    // only touch the matcher's cache line when our cached view says the ring is full
+    while (cachedGate < wrapPoint) {
+        cachedGate = matched.value.load(std::memory_order_acquire);
+        if (cachedGate < wrapPoint) {
+            idle();
+        }
+    }
+    OrderCommand& slot = ring[sequence & mask];
+    slot = command;
+    slot.rejected = false;
+    if (config.latencySampleCapacity > 0) {
+        slot.publishTimeNs = nowNs();
+    }
+    published.value.store(sequence, std::memory_order_release);
+}
+
+void OrderPipeline::drain() const {
+    if (!running.load()) {
+        throw std::logic_error("pipeline must be started before draining");
+    }
+    int64_t last = published.value.load(std::memory_order_relaxed);
+    while (matched.value.load(std::memory_order_acquire) < last) {
+        idle();
+    }
+}
+
+PipelineStats OrderPipeline::getStats() const noexcept {
+    return {processedCount, rejectedCount};
+}
+
+int64_t OrderPipeline::waitFor(const PaddedSequence& dependency, int64_t sequence) const {
+    int64_t available;
+    while ((available = dependency.value.load(std::memory_order_acquire)) < sequence) {
+        if (!running.load(std::memory_order_relaxed)) {
+            return available;
+        }
+        idle();
+    }
+    return available;
+}
+
+void OrderPipeline::idle() const noexcept {
+    if (config.waitStrategy == WaitStrategy::YIELD) {
+        std::this_thread::yield();
+        return;
+    }
+    // tell the cpu we're spinning so the hyperthread sibling isn't starved
+    // and the loop exits quickly once the sequence changes
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield");
+#endif
+}
+
+void OrderPipeline::pinToCore(std::thread& thread, int core) {
+    if (core < 0) {
+        return;
+    }
+#ifdef __linux__
+    setAffinity(thread.native_handle(), core);
+#else
+    (void)thread; // pinning is Linux only, other platforms run unpinned
+#endif
+}
+
+void OrderPipeline::pinCurrentThread(int core) {
+    if (core < 0) {
+        return;
+    }
+#ifdef __linux__
+    if (core >= CPU_SETSIZE) {
+        throw std::invalid_argument("core id out of range");
+    }
+    setAffinity(pthread_self(), core);
+#endif
+}
+
+void OrderPipeline::runSequencer() {
+    // resume after whatever this stage handled before a restart
+    int64_t next = sequenced.value.load(std::memory_order_relaxed) + 1;
+    while (true) {
+        int64_t available = waitFor(published, next);
+        if (available < next) {
+            return;
+        }
+        for (; next <= available; ++next) {
+            OrderCommand& command = ring[next & mask];
+            // decode: reject malformed commands before they reach risk or matching
+            command.rejected = !isWellFormed(command);
+        }
+        sequenced.value.store(available, std::memory_order_release);
+    }
+}
+
+void OrderPipeline::runRisk() {
+    // resume after whatever this stage handled before a restart
+    int64_t next = riskChecked.value.load(std::memory_order_relaxed) + 1;
+    while (true) {
+        int64_t available = waitFor(sequenced, next);
+        if (available < next) {
+            return;
+        }
+        for (; next <= available; ++next) {
+            OrderCommand& command = ring[next & mask];
+            if (!command.rejected) {
+                if (riskChecker.needsBook(command)) {
+                    waitForMatcher(next);
+                }
+                command.rejected = !riskChecker.check(command, book);
+            }
+        }
+        riskChecked.value.store(available, std::memory_order_release);
+    }
+}
+
+// publish risk progress up to the previous command and wait for the matcher to
+// apply it; the matcher then blocks on riskChecked, so the book is safe to read
+void OrderPipeline::waitForMatcher(int64_t sequence) {
+    riskChecked.value.store(sequence - 1, std::memory_order_release);
+    waitFor(matched, sequence - 1);
+}
+
+void OrderPipeline::runMatcher() {
+    // resume after whatever this stage handled before a restart
+    int64_t next = matched.value.load(std::memory_order_relaxed) + 1;
+    while (true) {
+        int64_t available = waitFor(riskChecked, next);
+        if (available < next) {
+            return;
+        }
+        for (; next <= available; ++next) {
+            const OrderCommand& command = ring[next & mask];
+            if (command.rejected) {
+                ++rejectedCount;
+            } else {
+                applyCommand(book, command);
+            }
+            if (latencySamples.size() < config.latencySampleCapacity) {
+                latencySamples.push_back(nowNs() - command.publishTimeNs);
+            }
+            ++processedCount;
+        }
+        matched.value.store(available, std::memory_order_release);
+    }
+}